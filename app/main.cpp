@@ -1,4 +1,5 @@
 #include "Logger/Logger.h"
+#include "Logger/SharedMemoryRing.h"
 
 #include <iostream>
 #include <thread>
@@ -7,6 +8,10 @@
 #include <condition_variable>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 
 using namespace LoggerLib;
 
@@ -49,36 +54,125 @@ LogLevel parse_level(const std::string& s) {
 
 void print_usage(const char* prog) {
     std::cout << "Usage:\n"
-              << prog << " <log_file> <default_level: error|warning|info> [socket_host socket_port]\n\n"
+              << prog << " <log_file> <default_level: error|warning|info> [socket_host socket_port [socket_level]]\n"
+              << prog << " --shm <shm_name> <default_level>\n"
+              << prog << " --drain <shm_name> <log_file> [socket_host socket_port [socket_level]]\n\n"
               << "Examples:\n"
               << prog << " log.txt info\n"
-              << prog << " log.txt warning 127.0.0.1 5000\n";
+              << prog << " log.txt warning 127.0.0.1 5000\n"
+              << prog << " log.txt info 127.0.0.1 5000 error\n"
+              << prog << " --drain /logger log.txt 127.0.0.1 5000 error\n"
+              << prog << " --shm /logger info\n";
 }
 
-int main(int argc, char* argv[]) {
-    // part 2,2 - parameters: filename and default level; optional socket host+port
-    if (argc != 3 && argc != 5) {
+std::atomic<bool> drain_running(true);
+
+void drain_signal_handler(int) {
+    drain_running = false;
+}
+
+// drain mode: owns the shared memory ring and moves lines from all worker processes
+// to the real file/socket destinations. Stops on SIGINT/SIGTERM after emptying the ring.
+int run_drain(int argc, char* argv[]) {
+    if (argc != 4 && argc != 6 && argc != 7) {
         print_usage(argv[0]);
         return 1;
     }
 
-    std::string log_filename = argv[1];
-    LogLevel default_level = parse_level(argv[2]);
+    auto ring = SharedMemoryRing::Create(argv[2]);
+    if (!ring) return 1;
 
-    std::string socket_host;
-    uint16_t socket_port = 0;
-    if (argc == 5) {
-        socket_host = argv[3];
-        int p = std::stoi(argv[4]);
+    std::vector<std::unique_ptr<ILogDestination>> destinations;
+    destinations.push_back(std::make_unique<FileDestination>(argv[3]));
+    if (argc >= 6) {
+        int p = std::stoi(argv[5]);
         if (p <= 0 || p > 65535) {
             std::cerr << "Invalid port\n";
             return 1;
         }
-        socket_port = static_cast<uint16_t>(p);
+        auto socket_dest = std::make_unique<SocketDestination>(argv[4], static_cast<uint16_t>(p));
+        if (argc == 7) socket_dest->SetMinLevel(parse_level(argv[6]));
+        destinations.push_back(std::move(socket_dest));
+    }
+
+    std::signal(SIGINT, drain_signal_handler);
+    std::signal(SIGTERM, drain_signal_handler);
+    std::cout << "Draining " << argv[2] << ". Press Ctrl+C to stop.\n";
+
+    SharedMemoryRecord record;
+    while (true) {
+        bool stopping = !drain_running;
+        bool any = false;
+        while (ring->TryPop(record)) {
+            any = true;
+            // route on the raw message and the level recorded by the worker
+            std::string message = record.Message();
+            for (auto& dest : destinations) {
+                if (dest->Accepts(message, record.level)) dest->WriteLogLine(record.line);
+            }
+        }
+        if (stopping) break;
+        if (!any) std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 
-    // part 2,1,a & 1.6 - create logger with file and optional socket destination(s)
-    auto logger = Logger::CreateWithFileAndOptionalSocket(log_filename, default_level, socket_host, socket_port);
+    if (ring->DroppedCount() > 0) {
+        std::cerr << "Dropped lines (ring full): " << ring->DroppedCount() << "\n";
+    }
+    if (ring->SkippedCount() > 0) {
+        std::cerr << "Skipped slots (abandoned by crashed workers): " << ring->SkippedCount() << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = argc >= 2 ? argv[1] : "";
+    if (mode == "--drain") return run_drain(argc, argv);
+
+    std::shared_ptr<Logger> logger;
+    LogLevel default_level;
+    if (mode == "--shm") {
+        // worker mode: all lines go to the ring of a drain process
+        if (argc != 4) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        default_level = parse_level(argv[3]);
+        auto shm_dest = std::make_unique<SharedMemoryDestination>(argv[2]);
+        if (!shm_dest->IsAttached()) {
+            std::cerr << "No drain is running for " << argv[2] << " (start " << argv[0] << " --drain first)\n";
+            return 1;
+        }
+        logger = std::make_shared<Logger>(default_level);
+        logger->AddDestination(std::move(shm_dest));
+    } else {
+        // part 2,2 - parameters: filename and default level; optional socket host+port and socket level
+        if (argc != 3 && argc != 5 && argc != 6) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        std::string log_filename = argv[1];
+        default_level = parse_level(argv[2]);
+
+        std::string socket_host;
+        uint16_t socket_port = 0;
+        LogLevel socket_level = LogLevel::Info;
+        if (argc >= 5) {
+            socket_host = argv[3];
+            int p = std::stoi(argv[4]);
+            if (p <= 0 || p > 65535) {
+                std::cerr << "Invalid port\n";
+                return 1;
+            }
+            socket_port = static_cast<uint16_t>(p);
+        }
+        if (argc == 6) {
+            socket_level = parse_level(argv[5]);
+        }
+
+        // part 2,1,a & 1.6 - create logger with file and optional socket destination(s)
+        logger = Logger::CreateWithFileAndOptionalSocket(log_filename, default_level, socket_host, socket_port, socket_level);
+    }
 
     // start logger thread
     std::thread worker(logger_thread_func, logger);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+// Нормализация сообщения в шаблон: числа и hex-идентификаторы заменяются на '#'
+// (в том числе временная метка), длина шаблона ограничена
+const size_t MAX_TEMPLATE_LEN = 128;
+
+std::string normalize_template(const std::string& message);
+
+// 64-битный хеш (FNV-1a + перемешивание splitmix64)
+uint64_t hash_template(const std::string& s);
+
+// HyperLogLog: оценка числа различных шаблонов, 2^12 однобайтовых регистров
+struct HyperLogLog {
+    static constexpr int P = 12;
+    static constexpr size_t M = size_t(1) << P;
+    std::array<uint8_t, M> registers{};
+
+    void add(uint64_t h) {
+        size_t idx = h >> (64 - P);
+        uint64_t rest = h << P;
+        uint8_t rank = rest == 0 ? (64 - P + 1) : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        if (rank > registers[idx]) registers[idx] = rank;
+    }
+
+    double estimate() const {
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (uint8_t r : registers) {
+            sum += std::ldexp(1.0, -r);
+            if (r == 0) zeros++;
+        }
+        double m = static_cast<double>(M);
+        double e = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+        // поправка для малых значений (linear counting)
+        if (e <= 2.5 * m && zeros != 0) e = m * std::log(m / zeros);
+        return e;
+    }
+};
+
+// Space-Saving: приблизительный top-K самых частых шаблонов с фиксированным числом счётчиков.
+// count - оценка сверху, count - error - гарантированный минимум
+struct SpaceSaving {
+    static constexpr size_t CAPACITY = 64;
+
+    struct Entry {
+        uint64_t hash = 0;
+        std::string templ;
+        size_t count = 0;
+        size_t error = 0;
+    };
+    std::vector<Entry> entries;
+
+    SpaceSaving() { entries.reserve(CAPACITY); }
+
+    void add(uint64_t h, const std::string& templ) {
+        for (auto& e : entries) {
+            if (e.hash == h && e.templ == templ) {
+                e.count++;
+                return;
+            }
+        }
+        if (entries.size() < CAPACITY) {
+            entries.push_back({h, templ, 1, 0});
+            return;
+        }
+        // вытесняем счётчик с минимальным значением
+        auto min_it = std::min_element(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.count < b.count; });
+        min_it->hash = h;
+        min_it->templ = templ;
+        min_it->error = min_it->count;
+        min_it->count++;
+    }
+
+    std::vector<Entry> top(size_t k) const {
+        std::vector<Entry> result(entries);
+        std::sort(result.begin(), result.end(),
+            [](const Entry& a, const Entry& b) { return a.count > b.count; });
+        if (result.size() > k) result.resize(k);
+        return result;
+    }
+};
+
+const size_t TOP_K = 10;
+
+// Скользящее окно за час: счётчики по секундам (фиксированный размер, пригоден для снимка)
+const size_t LAST_HOUR_SECONDS = 3600;
+
+struct SecondBucket {
+    int64_t second = 0; // секунды от эпохи
+    uint64_t count = 0;
+};
+
+// Структура для статистики
+struct Stats {
+    size_t total_messages = 0;
+    size_t errors = 0;
+    size_t warnings = 0;
+    size_t infos = 0;
+
+    size_t min_len = SIZE_MAX;
+    size_t max_len = 0;
+    double avg_len = 0.0;
+
+    std::array<SecondBucket, LAST_HOUR_SECONDS> last_hour{};
+
+    // частые шаблоны и число различных шаблонов (фиксированная память)
+    SpaceSaving top_templates;
+    HyperLogLog distinct_templates;
+};
+
+// секунды от эпохи (системные часы)
+int64_t epoch_seconds();
+
+// Учёт одного сообщения; templ и h - результат normalize_template/hash_template,
+// now - время получения в секундах от эпохи. Вызывающий отвечает за блокировку.
+void add_message(Stats& stats, const std::string& message, const std::string& templ, uint64_t h, int64_t now);
+
+// Число сообщений за последний час на момент now
+uint64_t last_hour_count(const Stats& stats, int64_t now);
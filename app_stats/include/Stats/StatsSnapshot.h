@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Stats/Stats.h"
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Снимки статистики.
+// Файл отображается в память и содержит два слота. Запись идёт в слот с более старым
+// поколением, поколение записывается последним (после msync данных), поэтому при
+// падении во время записи остаётся целым предыдущий слот. Загрузка - копирование
+// слота фиксированного размера, без повторного чтения логов.
+
+const uint32_t SNAPSHOT_MAGIC = 0x53544154; // "STAT"
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotTemplate {
+    uint64_t hash;
+    uint64_t count;
+    uint64_t error;
+    uint32_t len;
+    char templ[MAX_TEMPLATE_LEN];
+};
+
+struct StatsSnapshot {
+    uint64_t total_messages;
+    uint64_t errors;
+    uint64_t warnings;
+    uint64_t infos;
+    uint64_t min_len;
+    uint64_t max_len;
+    double avg_len;
+    SecondBucket last_hour[LAST_HOUR_SECONDS];
+    uint8_t hll_registers[HyperLogLog::M];
+    uint32_t template_count;
+    SnapshotTemplate templates[SpaceSaving::CAPACITY];
+};
+
+struct SnapshotSlot {
+    uint64_t generation; // 0 - слот пуст или пишется
+    uint64_t checksum;
+    StatsSnapshot data;
+};
+
+struct SnapshotFile {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t slot_size;
+    SnapshotSlot slots[2];
+};
+
+uint64_t checksum_bytes(const void* data, size_t size);
+
+// Копирование состояния в снимок и обратно (без аллокаций при заполнении снимка)
+void fill_snapshot(const Stats& stats, StatsSnapshot& snap);
+void restore_snapshot(const StatsSnapshot& snap, Stats& stats);
+
+class SnapshotStore {
+public:
+    // stats/stats_mutex - состояние, которое сохраняется и восстанавливается
+    SnapshotStore(Stats& stats, std::mutex& stats_mutex);
+    ~SnapshotStore();
+
+    // Открыть файл снимков. Новый, пустой или заполненный нулями (незавершённая
+    // инициализация) файл инициализируется; файл другого формата не трогается -
+    // возвращается false.
+    bool open(const std::string& path);
+
+    // Загрузка последнего целого снимка в stats
+    bool load();
+
+    // Под мьютексом состояние копируется в буфер в куче, запись в файл идёт уже без него
+    void save();
+
+private:
+    Stats& stats_;
+    std::mutex& stats_mutex_;
+    SnapshotFile* file_ = nullptr;
+    uint64_t generation_ = 0;
+    std::unique_ptr<StatsSnapshot> staging_;
+};
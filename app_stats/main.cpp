@@ -1,34 +1,24 @@
+#include "Stats/Stats.h"
+#include "Stats/StatsSnapshot.h"
+
 #include <iostream>
 #include <string>
 #include <sstream>
-#include <deque>
 #include <chrono>
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <algorithm>
+#include <memory>
 #include <netinet/in.h>
 #include <unistd.h>
 
-// Структура для статистики
-struct Stats {
-    size_t total_messages = 0;
-    size_t errors = 0;
-    size_t warnings = 0;
-    size_t infos = 0;
-
-    size_t min_len = SIZE_MAX;
-    size_t max_len = 0;
-    double avg_len = 0.0;
-
-    std::deque<std::chrono::system_clock::time_point> last_hour_msgs;
-};
-
 // Глобальные переменные
 Stats stats;
 std::mutex stats_mutex;
 std::atomic<bool> changed(false);
 std::atomic<bool> running(true);
+std::atomic<bool> snapshot_dirty(false);
 
 void print_stats() {
     std::lock_guard<std::mutex> lock(stats_mutex);
@@ -39,18 +29,20 @@ void print_stats() {
               << ", Warnings: " << stats.warnings
               << ", Infos: " << stats.infos << "\n";
 
-    // Чистим старые сообщения старше 1 часа
-    auto now = std::chrono::system_clock::now();
-    while (!stats.last_hour_msgs.empty() &&
-           std::chrono::duration_cast<std::chrono::hours>(now - stats.last_hour_msgs.front()).count() >= 1) {
-        stats.last_hour_msgs.pop_front();
-    }
-    std::cout << "Messages in last hour: " << stats.last_hour_msgs.size() << "\n";
+    std::cout << "Messages in last hour: " << last_hour_count(stats, epoch_seconds()) << "\n";
 
     if (stats.total_messages > 0) {
         std::cout << "Min length: " << stats.min_len << "\n";
         std::cout << "Max length: " << stats.max_len << "\n";
         std::cout << "Avg length: " << stats.avg_len << "\n";
+        std::cout << "Distinct templates (approx): "
+                  << static_cast<size_t>(stats.distinct_templates.estimate() + 0.5) << "\n";
+        std::cout << "Top templates:\n";
+        for (const auto& e : stats.top_templates.top(TOP_K)) {
+            std::cout << "  " << e.count;
+            if (e.error > 0) std::cout << " (>= " << e.count - e.error << ")";
+            std::cout << "  " << e.templ << "\n";
+        }
     } else {
         std::cout << "No messages yet.\n";
     }
@@ -74,26 +66,35 @@ void timer_thread_func(int T) {
 
 // Обновление статистики
 void update_stats(const std::string& message) {
-    std::lock_guard<std::mutex> lock(stats_mutex);
-
-    stats.total_messages++;
-    size_t len = message.size();
-    stats.min_len = std::min(stats.min_len, len);
-    stats.max_len = std::max(stats.max_len, len);
-    stats.avg_len = ((stats.avg_len * (stats.total_messages - 1)) + len) / stats.total_messages;
+    // шаблон считается до захвата мьютекса
+    std::string templ = normalize_template(message);
+    uint64_t h = hash_template(templ);
 
-    // Определение уровня по содержимому
-    if (message.find("[Error]") != std::string::npos) stats.errors++;
-    else if (message.find("[Warning]") != std::string::npos) stats.warnings++;
-    else if (message.find("[Info]") != std::string::npos) stats.infos++;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        add_message(stats, message, templ, h, epoch_seconds());
+    }
 
-    stats.last_hour_msgs.push_back(std::chrono::system_clock::now());
     changed.store(true);
+    snapshot_dirty.store(true);
+}
+
+// Поток периодических снимков
+void snapshot_thread_func(SnapshotStore* store, int period) {
+    auto last_save = std::chrono::steady_clock::now();
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration_cast<std::chrono::seconds>(now - last_save).count() >= period) {
+            if (snapshot_dirty.exchange(false)) store->save();
+            last_save = now;
+        }
+    }
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <port> <N> <T>\n";
+    if (argc < 4 || argc > 6) {
+        std::cerr << "Usage: " << argv[0] << " <port> <N> <T> [<snapshot_file> [<snapshot_period>]]\n";
         return 1;
     }
 
@@ -101,6 +102,18 @@ int main(int argc, char* argv[]) {
     int N = std::stoi(argv[2]);
     int T = std::stoi(argv[3]);
 
+    // Восстановление статистики из снимка
+    std::unique_ptr<SnapshotStore> snapshots;
+    int snapshot_period = argc == 6 ? std::max(1, std::stoi(argv[5])) : 5;
+    if (argc >= 5) {
+        snapshots = std::make_unique<SnapshotStore>(stats, stats_mutex);
+        if (!snapshots->open(argv[4])) return 1;
+        if (snapshots->load()) {
+            std::cout << "Restored statistics from " << argv[4] << "\n";
+            print_stats();
+        }
+    }
+
     // Создание сокета
     int server_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (server_fd < 0) {
@@ -139,9 +152,11 @@ int main(int argc, char* argv[]) {
 
     // Запуск таймера
     std::thread timer_thread(timer_thread_func, T);
+    std::thread snapshot_thread;
+    if (snapshots) snapshot_thread = std::thread(snapshot_thread_func, snapshots.get(), snapshot_period);
 
     char buffer[1024];
-    size_t last_stat_count = 0;
+    size_t last_stat_count = stats.total_messages;
     while (true) {
         ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
         if (bytes_read <= 0) break;
@@ -164,6 +179,8 @@ int main(int argc, char* argv[]) {
 
     running = false;
     timer_thread.join();
+    if (snapshot_thread.joinable()) snapshot_thread.join();
+    if (snapshots) snapshots->save();
     close(client_fd);
     close(server_fd);
 
@@ -0,0 +1,91 @@
+#include "Stats/Stats.h"
+
+#include <cctype>
+#include <chrono>
+
+std::string normalize_template(const std::string& message) {
+    std::string out;
+    out.reserve(std::min(message.size(), MAX_TEMPLATE_LEN));
+    size_t i = 0;
+    while (i < message.size() && out.size() < MAX_TEMPLATE_LEN) {
+        unsigned char c = static_cast<unsigned char>(message[i]);
+        if (!std::isalnum(c)) {
+            out.push_back(static_cast<char>(c));
+            i++;
+            continue;
+        }
+        // слово из букв/цифр
+        size_t j = i;
+        bool has_digit = false, all_hex = true;
+        while (j < message.size() && std::isalnum(static_cast<unsigned char>(message[j]))) {
+            unsigned char w = static_cast<unsigned char>(message[j]);
+            if (std::isdigit(w)) has_digit = true;
+            if (!std::isxdigit(w)) all_hex = false;
+            j++;
+        }
+        bool hex_prefix = j - i > 2 && message[i] == '0' && (message[i + 1] == 'x' || message[i + 1] == 'X');
+        if (hex_prefix || (has_digit && all_hex)) {
+            out.push_back('#');
+        } else {
+            // цифры внутри слова схлопываются в один '#'
+            for (size_t k = i; k < j && out.size() < MAX_TEMPLATE_LEN; k++) {
+                if (std::isdigit(static_cast<unsigned char>(message[k]))) {
+                    if (out.empty() || out.back() != '#') out.push_back('#');
+                } else {
+                    out.push_back(message[k]);
+                }
+            }
+        }
+        i = j;
+    }
+    return out;
+}
+
+uint64_t hash_template(const std::string& s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+int64_t epoch_seconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void add_message(Stats& stats, const std::string& message, const std::string& templ, uint64_t h, int64_t now) {
+    stats.total_messages++;
+    size_t len = message.size();
+    stats.min_len = std::min(stats.min_len, len);
+    stats.max_len = std::max(stats.max_len, len);
+    stats.avg_len = ((stats.avg_len * (stats.total_messages - 1)) + len) / stats.total_messages;
+
+    // Определение уровня по содержимому
+    if (message.find("[Error]") != std::string::npos) stats.errors++;
+    else if (message.find("[Warning]") != std::string::npos) stats.warnings++;
+    else if (message.find("[Info]") != std::string::npos) stats.infos++;
+
+    stats.top_templates.add(h, templ);
+    stats.distinct_templates.add(h);
+
+    SecondBucket& bucket = stats.last_hour[static_cast<uint64_t>(now) % LAST_HOUR_SECONDS];
+    if (bucket.second != now) {
+        bucket.second = now;
+        bucket.count = 0;
+    }
+    bucket.count++;
+}
+
+uint64_t last_hour_count(const Stats& stats, int64_t now) {
+    // Учитываем только секунды моложе 1 часа
+    uint64_t count = 0;
+    for (const auto& b : stats.last_hour) {
+        if (b.count > 0 && now - b.second < static_cast<int64_t>(LAST_HOUR_SECONDS)) count += b.count;
+    }
+    return count;
+}
@@ -0,0 +1,158 @@
+#include "Stats/StatsSnapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+uint64_t checksum_bytes(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+void fill_snapshot(const Stats& stats, StatsSnapshot& snap) {
+    snap.total_messages = stats.total_messages;
+    snap.errors = stats.errors;
+    snap.warnings = stats.warnings;
+    snap.infos = stats.infos;
+    snap.min_len = stats.min_len;
+    snap.max_len = stats.max_len;
+    snap.avg_len = stats.avg_len;
+    std::copy(stats.last_hour.begin(), stats.last_hour.end(), snap.last_hour);
+    std::copy(stats.distinct_templates.registers.begin(), stats.distinct_templates.registers.end(),
+              snap.hll_registers);
+    snap.template_count = static_cast<uint32_t>(stats.top_templates.entries.size());
+    for (size_t i = 0; i < stats.top_templates.entries.size(); i++) {
+        const auto& e = stats.top_templates.entries[i];
+        SnapshotTemplate& t = snap.templates[i];
+        t.hash = e.hash;
+        t.count = e.count;
+        t.error = e.error;
+        t.len = static_cast<uint32_t>(std::min(e.templ.size(), MAX_TEMPLATE_LEN));
+        std::copy(e.templ.begin(), e.templ.begin() + t.len, t.templ);
+    }
+}
+
+void restore_snapshot(const StatsSnapshot& snap, Stats& stats) {
+    stats.total_messages = snap.total_messages;
+    stats.errors = snap.errors;
+    stats.warnings = snap.warnings;
+    stats.infos = snap.infos;
+    stats.min_len = snap.min_len;
+    stats.max_len = snap.max_len;
+    stats.avg_len = snap.avg_len;
+    std::copy(snap.last_hour, snap.last_hour + LAST_HOUR_SECONDS, stats.last_hour.begin());
+    std::copy(snap.hll_registers, snap.hll_registers + HyperLogLog::M,
+              stats.distinct_templates.registers.begin());
+    stats.top_templates.entries.clear();
+    uint32_t n = std::min<uint32_t>(snap.template_count, SpaceSaving::CAPACITY);
+    for (uint32_t i = 0; i < n; i++) {
+        const SnapshotTemplate& t = snap.templates[i];
+        uint32_t len = std::min<uint32_t>(t.len, MAX_TEMPLATE_LEN);
+        stats.top_templates.entries.push_back({t.hash, std::string(t.templ, len), t.count, t.error});
+    }
+}
+
+SnapshotStore::SnapshotStore(Stats& stats, std::mutex& stats_mutex)
+    : stats_(stats), stats_mutex_(stats_mutex), staging_(std::make_unique<StatsSnapshot>()) {
+}
+
+SnapshotStore::~SnapshotStore() {
+    if (file_) munmap(file_, sizeof(SnapshotFile));
+}
+
+bool SnapshotStore::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("snapshot open");
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        perror("snapshot fstat");
+        close(fd);
+        return false;
+    }
+    // размер проверяется до ftruncate, чтобы случайно указанный чужой файл не был испорчен
+    bool fresh = st.st_size == 0;
+    if (!fresh && static_cast<size_t>(st.st_size) != sizeof(SnapshotFile)) {
+        std::cerr << path << " is not a statistics snapshot file\n";
+        close(fd);
+        return false;
+    }
+    if (fresh && ftruncate(fd, sizeof(SnapshotFile)) != 0) {
+        perror("snapshot ftruncate");
+        close(fd);
+        return false;
+    }
+
+    void* base = mmap(nullptr, sizeof(SnapshotFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("snapshot mmap");
+        return false;
+    }
+    file_ = static_cast<SnapshotFile*>(base);
+
+    // файл нужного размера из одних нулей - падение между ftruncate и записью заголовка
+    if (!fresh) {
+        const char* bytes = static_cast<const char*>(base);
+        fresh = std::all_of(bytes, bytes + sizeof(SnapshotFile), [](char c) { return c == 0; });
+    }
+
+    if (fresh) {
+        file_->magic = SNAPSHOT_MAGIC;
+        file_->version = SNAPSHOT_VERSION;
+        file_->slot_size = sizeof(SnapshotSlot);
+        msync(file_, sizeof(SnapshotFile), MS_SYNC);
+    } else if (file_->magic != SNAPSHOT_MAGIC || file_->version != SNAPSHOT_VERSION ||
+               file_->slot_size != sizeof(SnapshotSlot)) {
+        std::cerr << path << " is not a statistics snapshot file (or has another version)\n";
+        munmap(file_, sizeof(SnapshotFile));
+        file_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotStore::load() {
+    const SnapshotSlot* best = nullptr;
+    for (const auto& slot : file_->slots) {
+        if (slot.generation == 0) continue;
+        if (slot.checksum != checksum_bytes(&slot.data, sizeof(slot.data))) continue;
+        if (!best || slot.generation > best->generation) best = &slot;
+    }
+    if (!best) return false;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        restore_snapshot(best->data, stats_);
+    }
+    generation_ = best->generation;
+    return true;
+}
+
+void SnapshotStore::save() {
+    // под мьютексом - только копирование в память процесса
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        fill_snapshot(stats_, *staging_);
+    }
+
+    SnapshotSlot& slot = file_->slots[(generation_ + 1) % 2];
+    slot.generation = 0;
+    std::memcpy(&slot.data, staging_.get(), sizeof(StatsSnapshot));
+    slot.checksum = checksum_bytes(&slot.data, sizeof(slot.data));
+    msync(file_, sizeof(SnapshotFile), MS_SYNC);
+    slot.generation = ++generation_;
+    msync(file_, sizeof(SnapshotFile), MS_SYNC);
+}
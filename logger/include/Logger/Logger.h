@@ -8,6 +8,7 @@
 #include <memory>
 #include <vector>
 #include <atomic>
+#include <functional>
 
 #ifdef __linux__
 #include <sys/socket.h>
@@ -24,12 +25,43 @@ enum class LogLevel {
     Info = 2
 };
 
+// Routing predicate: receives the raw (unformatted) message and its level,
+// returns true if the destination wants the line
+using LogFilter = std::function<bool(const std::string& message, LogLevel level)>;
+
+// helper - predicate that accepts messages starting with prefix
+LogFilter MakePrefixFilter(const std::string& prefix);
+
+// helper - predicate that accepts messages containing tag (e.g. "[net]")
+LogFilter MakeTagFilter(const std::string& tag);
+
 // Interface for a log destination (file, socket, ...)
 class ILogDestination {
 public:
     virtual ~ILogDestination() = default;
     // part 1,3,a,b,c) - write one formatted log line to the destination
     virtual void WriteLogLine(const std::string& line) = 0;
+
+    // write a line together with its raw message and level (Logger uses this);
+    // destinations that do not need them just write the line
+    virtual void WriteLogRecord(const std::string& line, const std::string& message, LogLevel level) {
+        (void)message; (void)level;
+        WriteLogLine(line);
+    }
+
+    // per-destination minimum level (default: accept everything)
+    void SetMinLevel(LogLevel level) { min_level_ = level; }
+    LogLevel GetMinLevel() const { return min_level_; }
+
+    // optional routing predicate (empty - accept every line passing the level check)
+    void SetFilter(LogFilter filter) { filter_ = std::move(filter); }
+
+    // true if the destination wants a message of the given level
+    bool Accepts(const std::string& message, LogLevel level) const;
+
+private:
+    LogLevel min_level_ = LogLevel::Info;
+    LogFilter filter_;
 };
 
 // File destination implementation
@@ -69,6 +101,27 @@ private:
 #endif
 };
 
+class SharedMemoryRing;
+
+// Shared memory destination: appends lines to a ring drained by another process
+// (LoggerApp --drain). If the segment does not exist, destination becomes inactive.
+class SharedMemoryDestination : public ILogDestination {
+public:
+    explicit SharedMemoryDestination(const std::string& shm_name);
+    ~SharedMemoryDestination() override;
+
+    // lock-free append; the line is dropped if the ring is full or inactive
+    void WriteLogLine(const std::string& line) override;
+
+    // keeps level and raw message offset so the drain can route the line
+    void WriteLogRecord(const std::string& line, const std::string& message, LogLevel level) override;
+
+    bool IsAttached() const;
+
+private:
+    std::unique_ptr<SharedMemoryRing> ring_;
+};
+
 // Main Logger: aggregates multiple destinations and does filtering by level
 class Logger {
 public:
@@ -86,10 +139,24 @@ public:
     LogLevel GetLogLevel() const;
 
     // part 1,2,a & 1.6 - add file destination (can be called multiple times)
-    void AddFileDestination(const std::string& filename);
+    // min_level/filter restrict which lines are routed to this destination
+    void AddFileDestination(const std::string& filename,
+                            LogLevel min_level = LogLevel::Info,
+                            LogFilter filter = nullptr);
 
     // part 1.5 & 1.6 - add socket destination (non-blocking for the caller; internal connection attempt done in ctor)
-    void AddSocketDestination(const std::string& host, uint16_t port);
+    void AddSocketDestination(const std::string& host, uint16_t port,
+                              LogLevel min_level = LogLevel::Info,
+                              LogFilter filter = nullptr);
+
+    // add shared memory destination (ring created by a drain process).
+    // Returns false (and adds nothing) if no drain owns shm_name.
+    bool AddSharedMemoryDestination(const std::string& shm_name,
+                                    LogLevel min_level = LogLevel::Info,
+                                    LogFilter filter = nullptr);
+
+    // add an arbitrary destination (its min level / filter are taken as already configured)
+    void AddDestination(std::unique_ptr<ILogDestination> destination);
 
     // part 1,3,a,b,c & 1.6 - log message with explicit level
     void Log(const std::string& message, LogLevel level);
@@ -101,7 +168,8 @@ public:
     static std::shared_ptr<Logger> CreateWithFileAndOptionalSocket(const std::string& filename,
                                                                    LogLevel level,
                                                                    const std::string& socket_host = "",
-                                                                   uint16_t socket_port = 0);
+                                                                   uint16_t socket_port = 0,
+                                                                   LogLevel socket_level = LogLevel::Info);
 
 private:
     // part 1,3,c) - generate timestamp string
@@ -117,8 +185,15 @@ private:
     LogLevel current_level_;
     mutable std::mutex level_mutex_;
 
+    // must be called with destinations_mutex_ held
+    void AddDestinationLocked(std::unique_ptr<ILogDestination> destination);
+
     std::vector<std::unique_ptr<ILogDestination>> destinations_;
     mutable std::mutex destinations_mutex_;
+
+    // most verbose min level over all destinations (-1 - no destinations);
+    // lets Log() reject lines nobody wants without taking destinations_mutex_
+    std::atomic<int> fanout_level_{-1};
 };
 
 } // namespace LoggerLib
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+#include "Logger/Logger.h"
+
+namespace LoggerLib {
+
+// One record popped from the ring: the formatted line plus what routing needs
+struct SharedMemoryRecord {
+    std::string line;           // formatted line (possibly truncated)
+    size_t message_offset = 0;  // start of the raw message inside line
+    LogLevel level = LogLevel::Info;
+
+    // raw (unformatted) message, as passed to Logger::Log
+    std::string Message() const { return line.substr(message_offset); }
+};
+
+// Bounded multi-producer / single-consumer ring of log lines living in a named
+// POSIX shared memory segment. Producers (any number of processes) append lines
+// lock-free; one drain process pops them in a single global order.
+// Names follow shm_open rules ("/logger"; a leading '/' is added if missing).
+class SharedMemoryRing {
+public:
+    // number of slots (power of two) and max bytes of one line (longer lines are truncated)
+    static constexpr uint32_t kDefaultCapacity = 4096;
+    static constexpr uint32_t kSlotDataSize = 487; // slot is 512 bytes
+
+    // a claimed but unpublished slot older than this is treated as abandoned
+    // by a crashed producer and skipped by the drain
+    static constexpr std::chrono::milliseconds kDefaultStuckSlotTimeout{1000};
+
+    // Non-copyable
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+    ~SharedMemoryRing();
+
+    // drain side - open the segment (creating it if needed) and take its ownership lock.
+    // A segment left by a previous drain, stopped or crashed, is reused as is: lines still
+    // in the ring get drained and running workers stay connected. The name is never unlinked.
+    // Returns nullptr (error is reported to stderr) if another drain owns the segment or
+    // its layout differs.
+    static std::unique_ptr<SharedMemoryRing> Create(const std::string& name,
+                                                    uint32_t capacity = kDefaultCapacity);
+
+    // producer side - attach to the segment of a running drain. Returns nullptr if the segment
+    // does not exist or no drain currently owns it.
+    static std::unique_ptr<SharedMemoryRing> Attach(const std::string& name);
+
+    // append a line; never blocks. Returns false (and counts a drop) if the ring is full.
+    // message_offset - where the raw message starts inside line.
+    // A producer stalled for longer than the stuck-slot timeout loses its line (counted as dropped);
+    // if it still writes into the reclaimed slot, the drain discards that slot (see SkippedCount).
+    bool TryPush(const std::string& line, size_t message_offset = 0, LogLevel level = LogLevel::Info);
+
+    // pop the next record (single consumer only). Returns false if the ring is empty
+    // or the next slot is still being written. A slot stuck longer than the stuck-slot
+    // timeout is skipped and counted, so one dead producer cannot stall the ring.
+    bool TryPop(SharedMemoryRecord& record);
+
+    // number of lines dropped by producers because the ring was full
+    // (or because the drain skipped their slot before they published it)
+    uint64_t DroppedCount() const;
+
+    // number of slots the drain skipped as abandoned or discarded as overwritten
+    // by a stalled producer (stale ticket or checksum mismatch)
+    uint64_t SkippedCount() const;
+
+    // drain side - how long a claimed slot may stay unpublished
+    void SetStuckSlotTimeout(std::chrono::milliseconds timeout) { stuck_timeout_ = timeout; }
+
+private:
+    // tests simulate crashed and stalled producers through ClaimTicket/Publish
+    friend class SharedMemoryRingTest;
+
+    struct Header;
+    struct Slot;
+
+    // capacity is the validated value, never re-read from the shared header
+    SharedMemoryRing(const std::string& name, void* base, size_t size, uint32_t capacity, int lock_fd);
+
+    // pid recorded by the drain that owns the segment behind fd (0 if unknown)
+    static long OwnerPid(int fd);
+
+    // producer steps of TryPush: take a ticket (false if full), then fill and publish its slot
+    bool ClaimTicket(uint64_t& pos);
+    bool Publish(uint64_t pos, const std::string& line, size_t message_offset, LogLevel level);
+
+    Slot* SlotAt(uint64_t pos) const;
+
+private:
+    std::string name_;
+    void* base_;
+    size_t size_;
+    int lock_fd_; // drain only: fd holding the ownership lock
+    Header* header_;
+    Slot* slots_;
+    uint32_t capacity_;
+    uint64_t mask_;
+
+    // drain side - ticket currently waited on and since when
+    uint64_t stuck_pos_ = UINT64_MAX;
+    std::chrono::steady_clock::time_point stuck_since_;
+    std::chrono::milliseconds stuck_timeout_ = kDefaultStuckSlotTimeout;
+};
+
+} // namespace LoggerLib
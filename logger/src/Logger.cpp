@@ -1,4 +1,5 @@
 #include "Logger/Logger.h"
+#include "Logger/SharedMemoryRing.h"
 #include <iomanip>
 #include <sstream>
 #include <iostream>
@@ -11,6 +12,25 @@
 
 namespace LoggerLib {
 
+/* ---------------- Routing ---------------- */
+
+LogFilter MakePrefixFilter(const std::string& prefix) {
+    return [prefix](const std::string& message, LogLevel) {
+        return message.compare(0, prefix.size(), prefix) == 0;
+    };
+}
+
+LogFilter MakeTagFilter(const std::string& tag) {
+    return [tag](const std::string& message, LogLevel) {
+        return message.find(tag) != std::string::npos;
+    };
+}
+
+bool ILogDestination::Accepts(const std::string& message, LogLevel level) const {
+    if (static_cast<int>(level) > static_cast<int>(min_level_)) return false;
+    return !filter_ || filter_(message, level);
+}
+
 /* ---------------- FileDestination ---------------- */
 
 // part 1,2,a - open file
@@ -125,6 +145,31 @@ void SocketDestination::WriteLogLine(const std::string& line) {
 #endif
 }
 
+/* ---------------- SharedMemoryDestination ---------------- */
+
+SharedMemoryDestination::SharedMemoryDestination(const std::string& shm_name)
+    : ring_(SharedMemoryRing::Attach(shm_name)) {
+}
+
+SharedMemoryDestination::~SharedMemoryDestination() = default;
+
+bool SharedMemoryDestination::IsAttached() const {
+    return ring_ != nullptr;
+}
+
+// no mutex: the ring itself is multi-producer safe across threads and processes
+void SharedMemoryDestination::WriteLogLine(const std::string& line) {
+    if (!ring_) return;
+    ring_->TryPush(line);
+}
+
+void SharedMemoryDestination::WriteLogRecord(const std::string& line, const std::string& message, LogLevel level) {
+    if (!ring_) return;
+    // the formatted line ends with the raw message
+    size_t offset = line.size() >= message.size() ? line.size() - message.size() : 0;
+    ring_->TryPush(line, offset, level);
+}
+
 /* ---------------- Logger ---------------- */
 
 // part 1,2,b - create with default level
@@ -145,39 +190,77 @@ LogLevel Logger::GetLogLevel() const {
 }
 
 // part 1.6 - add file destination
-void Logger::AddFileDestination(const std::string& filename) {
+void Logger::AddFileDestination(const std::string& filename, LogLevel min_level, LogFilter filter) {
+    auto dest = std::make_unique<FileDestination>(filename);
+    dest->SetMinLevel(min_level);
+    dest->SetFilter(std::move(filter));
     std::lock_guard<std::mutex> lock(destinations_mutex_);
-    destinations_.push_back(std::make_unique<FileDestination>(filename));
+    AddDestinationLocked(std::move(dest));
 }
 
 // part 1.5 & 1.6 - add socket destination
-void Logger::AddSocketDestination(const std::string& host, uint16_t port) {
+void Logger::AddSocketDestination(const std::string& host, uint16_t port, LogLevel min_level, LogFilter filter) {
+    // connect() blocks - do it before taking the lock so Log() is not stalled
+    auto dest = std::make_unique<SocketDestination>(host, port);
+    dest->SetMinLevel(min_level);
+    dest->SetFilter(std::move(filter));
     std::lock_guard<std::mutex> lock(destinations_mutex_);
-    std::cout << "k1" << std::endl;
-    destinations_.push_back(std::make_unique<SocketDestination>(host, port));
+    AddDestinationLocked(std::move(dest));
+}
+
+// shared memory destination
+bool Logger::AddSharedMemoryDestination(const std::string& shm_name, LogLevel min_level, LogFilter filter) {
+    auto dest = std::make_unique<SharedMemoryDestination>(shm_name);
+    if (!dest->IsAttached()) return false;
+    dest->SetMinLevel(min_level);
+    dest->SetFilter(std::move(filter));
+    std::lock_guard<std::mutex> lock(destinations_mutex_);
+    AddDestinationLocked(std::move(dest));
+    return true;
+}
+
+void Logger::AddDestination(std::unique_ptr<ILogDestination> destination) {
+    if (!destination) return;
+    std::lock_guard<std::mutex> lock(destinations_mutex_);
+    AddDestinationLocked(std::move(destination));
+}
+
+// keep fanout_level_ in sync with the destination list
+void Logger::AddDestinationLocked(std::unique_ptr<ILogDestination> destination) {
+    int level = static_cast<int>(destination->GetMinLevel());
+    if (level > fanout_level_.load()) fanout_level_.store(level);
+    destinations_.push_back(std::move(destination));
 }
 
 // part 1,3,a,b,c & 1.6 - log with explicit level (filtering applied here)
 void Logger::Log(const std::string& message, LogLevel level) {
-    // level check
+    // level check: logger-wide level, then the most verbose destination level
     {
         std::lock_guard<std::mutex> lock(level_mutex_);
         if (static_cast<int>(level) > static_cast<int>(current_level_)) {
             return; // lower priority -> ignore
         }
     }
+    if (static_cast<int>(level) > fanout_level_.load()) {
+        return; // no destination wants this level
+    }
 
-    std::string line = FormatLogLine(message, level);
-
-    // iterate destinations and write (each destination is responsible for its own locking)
+    // route to destinations (each destination is responsible for its own locking);
+    // the line is formatted once, and only if at least one destination accepts it
+    std::string line;
+    bool formatted = false;
     std::lock_guard<std::mutex> lock(destinations_mutex_);
     for (auto& dest : destinations_) {
-        if (dest) {
-            try {
-                dest->WriteLogLine(line);
-            } catch (...) {
-                // do not throw exceptions from logging - swallow errors
+        if (!dest) continue;
+        try {
+            if (!dest->Accepts(message, level)) continue;
+            if (!formatted) {
+                line = FormatLogLine(message, level);
+                formatted = true;
             }
+            dest->WriteLogRecord(line, message, level);
+        } catch (...) {
+            // do not throw exceptions from logging - swallow errors
         }
     }
 }
@@ -221,10 +304,11 @@ std::string Logger::FormatLogLine(const std::string& message, LogLevel level) co
 std::shared_ptr<Logger> Logger::CreateWithFileAndOptionalSocket(const std::string& filename,
                                                                 LogLevel level,
                                                                 const std::string& socket_host,
-                                                                uint16_t socket_port) {
+                                                                uint16_t socket_port,
+                                                                LogLevel socket_level) {
     auto logger = std::make_shared<Logger>(level);
     if (!filename.empty()) logger->AddFileDestination(filename);
-    if (!socket_host.empty() && socket_port != 0) logger->AddSocketDestination(socket_host, socket_port);
+    if (!socket_host.empty() && socket_port != 0) logger->AddSocketDestination(socket_host, socket_port, socket_level);
     return logger;
 }
 
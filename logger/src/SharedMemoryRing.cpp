@@ -0,0 +1,399 @@
+#include "Logger/SharedMemoryRing.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace LoggerLib {
+
+namespace {
+const uint32_t kMagic = 0x4C4F4752; // "LOGR"
+
+// POSIX shm names must start with '/'
+std::string ShmName(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+// FNV-1a over the slot contents
+uint32_t SlotChecksum(uint64_t ticket, uint16_t len, uint16_t offset, uint8_t level, const char* data) {
+    uint32_t h = 2166136261u;
+    auto mix = [&h](const void* p, size_t n) {
+        const unsigned char* b = static_cast<const unsigned char*>(p);
+        for (size_t i = 0; i < n; ++i) {
+            h ^= b[i];
+            h *= 16777619u;
+        }
+    };
+    mix(&ticket, sizeof(ticket));
+    mix(&len, sizeof(len));
+    mix(&offset, sizeof(offset));
+    mix(&level, sizeof(level));
+    mix(data, len);
+    return h;
+}
+
+#ifdef __linux__
+// Ownership lock of the drain: a whole-file OFD write lock. Like flock it belongs to the
+// open file description and is dropped by the kernel when the drain dies, but it can
+// also be tested (F_OFD_GETLK) without being taken.
+bool LockOwner(int fd) {
+    struct flock fl{};
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    return ::fcntl(fd, F_OFD_SETLK, &fl) == 0;
+}
+
+// true if some drain currently holds the ownership lock (the lock is not taken)
+bool IsOwnerLocked(int fd) {
+    struct flock fl{};
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    if (::fcntl(fd, F_OFD_GETLK, &fl) != 0) return false;
+    return fl.l_type != F_UNLCK;
+}
+#endif
+}
+
+// Segment layout: Header followed by capacity Slots.
+// Head/tail live on separate cache lines so producers and the drain do not contend.
+struct SharedMemoryRing::Header {
+    std::atomic<uint32_t> magic;
+    uint32_t capacity;
+    uint32_t slot_data_size;
+    int32_t owner_pid;                         // drain process (for diagnostics)
+    alignas(64) std::atomic<uint64_t> head;    // next ticket for producers
+    alignas(64) std::atomic<uint64_t> tail;    // next ticket for the drain
+    alignas(64) std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> skipped;
+};
+
+// seq == pos: free for ticket pos; seq == pos + 1: filled by ticket pos.
+// ticket and checksum let the drain reject a slot written by a stale producer.
+struct SharedMemoryRing::Slot {
+    std::atomic<uint64_t> seq;
+    uint64_t ticket;
+    uint32_t checksum;
+    uint16_t len;
+    uint16_t message_offset;
+    uint8_t level;
+    char data[kSlotDataSize];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory ring needs lock-free 64-bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory ring needs lock-free 32-bit atomics");
+
+SharedMemoryRing::SharedMemoryRing(const std::string& name, void* base, size_t size, uint32_t capacity, int lock_fd)
+    : name_(name), base_(base), size_(size), lock_fd_(lock_fd),
+      header_(static_cast<Header*>(base)),
+      slots_(reinterpret_cast<Slot*>(static_cast<char*>(base) + sizeof(Header))),
+      capacity_(capacity), mask_(capacity - 1) {
+    static_assert(sizeof(Slot) == 512, "slot should stay 512 bytes");
+}
+
+// the segment is never unlinked: a restarted drain picks up the lines still in it
+// and workers that are running stay connected
+SharedMemoryRing::~SharedMemoryRing() {
+#ifdef __linux__
+    if (base_) ::munmap(base_, size_);
+    if (lock_fd_ >= 0) ::close(lock_fd_); // releases the ownership lock
+#endif
+}
+
+#ifdef __linux__
+// pid recorded by the drain that owns the segment behind fd (0 if unknown)
+long SharedMemoryRing::OwnerPid(int fd) {
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) return 0;
+    void* base = ::mmap(nullptr, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) return 0;
+    long pid = static_cast<const Header*>(base)->owner_pid;
+    ::munmap(base, sizeof(Header));
+    return pid;
+}
+#endif
+
+std::unique_ptr<SharedMemoryRing> SharedMemoryRing::Create(const std::string& shm_name, uint32_t capacity) {
+#ifdef __linux__
+    std::string name = ShmName(shm_name);
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        std::cerr << "SharedMemoryRing: capacity must be a power of two\n";
+        return nullptr;
+    }
+
+    // open-or-create, then lock the same open file: there is no moment when
+    // the segment exists under this name without its owner holding the lock
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0) {
+        std::cerr << "SharedMemoryRing: shm_open failed for " << name << ": " << strerror(errno) << "\n";
+        return nullptr;
+    }
+    if (!LockOwner(fd)) {
+        if (errno == EAGAIN || errno == EACCES) {
+            long owner_pid = OwnerPid(fd);
+            std::cerr << "SharedMemoryRing: " << name << " is already drained by a running process";
+            if (owner_pid > 0) std::cerr << " (pid " << owner_pid << ")";
+            std::cerr << "\n";
+        } else {
+            std::cerr << "SharedMemoryRing: lock failed for " << name << ": " << strerror(errno) << "\n";
+        }
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_t size = sizeof(Header) + sizeof(Slot) * capacity;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        std::cerr << "SharedMemoryRing: fstat failed: " << strerror(errno) << "\n";
+        ::close(fd);
+        return nullptr;
+    }
+
+    // a segment left by a previous drain is reused as is, if its layout matches
+    bool reuse = false;
+    if (static_cast<size_t>(st.st_size) >= sizeof(Header)) {
+        void* probe = ::mmap(nullptr, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+        if (probe != MAP_FAILED) {
+            const Header* old = static_cast<const Header*>(probe);
+            if (old->magic.load(std::memory_order_acquire) == kMagic) {
+                reuse = true;
+                if (old->capacity != capacity || old->slot_data_size != kSlotDataSize ||
+                    static_cast<size_t>(st.st_size) != size) {
+                    std::cerr << "SharedMemoryRing: segment " << name
+                              << " has a different layout (remove /dev/shm" << name << " to recreate it)\n";
+                    ::munmap(probe, sizeof(Header));
+                    ::close(fd);
+                    return nullptr;
+                }
+            }
+            ::munmap(probe, sizeof(Header));
+        }
+    }
+
+    // new or never fully initialized (no magic - no worker can be attached to it)
+    if (!reuse && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "SharedMemoryRing: ftruncate failed: " << strerror(errno) << "\n";
+        ::close(fd);
+        return nullptr;
+    }
+
+    // fd stays open: it carries the ownership lock
+    void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "SharedMemoryRing: mmap failed: " << strerror(errno) << "\n";
+        ::close(fd);
+        return nullptr;
+    }
+
+    Header* header = static_cast<Header*>(base);
+    if (!reuse) {
+        std::memset(base, 0, size);
+        header = new (base) Header();
+        header->capacity = capacity;
+        header->slot_data_size = kSlotDataSize;
+        header->head.store(0);
+        header->tail.store(0);
+        header->dropped.store(0);
+        header->skipped.store(0);
+
+        Slot* slots = reinterpret_cast<Slot*>(static_cast<char*>(base) + sizeof(Header));
+        for (uint32_t i = 0; i < capacity; ++i) {
+            Slot* slot = new (&slots[i]) Slot();
+            slot->seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    header->owner_pid = static_cast<int32_t>(::getpid());
+
+    // publish: producers refuse to attach until magic is set
+    if (!reuse) header->magic.store(kMagic, std::memory_order_release);
+    return std::unique_ptr<SharedMemoryRing>(new SharedMemoryRing(name, base, size, capacity, fd));
+#else
+    (void)shm_name; (void)capacity;
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<SharedMemoryRing> SharedMemoryRing::Attach(const std::string& shm_name) {
+#ifdef __linux__
+    std::string name = ShmName(shm_name);
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        std::cerr << "SharedMemoryRing: shm_open failed for " << name << ": " << strerror(errno) << "\n";
+        return nullptr;
+    }
+
+    // the segment outlives its drain - only attach while a drain owns it
+    if (!IsOwnerLocked(fd)) {
+        std::cerr << "SharedMemoryRing: no drain is running for " << name << "\n";
+        ::close(fd);
+        return nullptr;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        std::cerr << "SharedMemoryRing: segment " << name << " is not initialized\n";
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "SharedMemoryRing: mmap failed: " << strerror(errno) << "\n";
+        return nullptr;
+    }
+
+    auto* header = static_cast<Header*>(base);
+    uint32_t capacity = header->capacity;
+    if (header->magic.load(std::memory_order_acquire) != kMagic ||
+        header->slot_data_size != kSlotDataSize ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        size != sizeof(Header) + sizeof(Slot) * capacity) {
+        std::cerr << "SharedMemoryRing: segment " << name << " has incompatible layout\n";
+        ::munmap(base, size);
+        return nullptr;
+    }
+
+    return std::unique_ptr<SharedMemoryRing>(new SharedMemoryRing(name, base, size, capacity, -1));
+#else
+    (void)shm_name;
+    return nullptr;
+#endif
+}
+
+SharedMemoryRing::Slot* SharedMemoryRing::SlotAt(uint64_t pos) const {
+    // mask cached at Create/Attach: a stray write to the shared header cannot move us out of bounds
+    return &slots_[pos & mask_];
+}
+
+bool SharedMemoryRing::TryPush(const std::string& line, size_t message_offset, LogLevel level) {
+    uint64_t pos = 0;
+    if (!ClaimTicket(pos)) {
+        // full - drop rather than block the caller
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return Publish(pos, line, message_offset, level);
+}
+
+// claim a ticket with CAS on head; false if the ring is full
+bool SharedMemoryRing::ClaimTicket(uint64_t& pos) {
+    pos = header_->head.load(std::memory_order_relaxed);
+    while (true) {
+        Slot* slot = SlotAt(pos);
+        uint64_t seq = slot->seq.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (header_->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return true;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = header_->head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// fill the claimed slot, then publish it via seq
+bool SharedMemoryRing::Publish(uint64_t pos, const std::string& line, size_t message_offset, LogLevel level) {
+    Slot* slot = SlotAt(pos);
+    uint16_t len = static_cast<uint16_t>(line.size() < kSlotDataSize ? line.size() : kSlotDataSize);
+    uint16_t offset = static_cast<uint16_t>(message_offset < len ? message_offset : len);
+    uint8_t lvl = static_cast<uint8_t>(level);
+
+    std::memcpy(slot->data, line.data(), len);
+    slot->ticket = pos;
+    slot->len = len;
+    slot->message_offset = offset;
+    slot->level = lvl;
+    // computed from the source line, so a slot garbled by a concurrent writer does not match
+    slot->checksum = SlotChecksum(pos, len, offset, lvl, line.data());
+
+    // publish with CAS: if the drain already gave up on this slot, the line is lost
+    uint64_t expected = pos;
+    if (!slot->seq.compare_exchange_strong(expected, pos + 1, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool SharedMemoryRing::TryPop(SharedMemoryRecord& record) {
+    while (true) {
+        uint64_t pos = header_->tail.load(std::memory_order_relaxed);
+        Slot* slot = SlotAt(pos);
+        uint64_t seq = slot->seq.load(std::memory_order_acquire);
+
+        if (seq == pos + 1) {
+            stuck_pos_ = UINT64_MAX;
+            // Copy first, then validate the copy. A producer that stalled past the timeout
+            // may still be writing into this slot after it was reclaimed and reused; its
+            // ticket is stale and the checksum of the mixed contents does not match.
+            uint64_t ticket = slot->ticket;
+            uint32_t checksum = slot->checksum;
+            // clamp everything that controls memory accesses: the slot is writable by any worker
+            uint16_t len = slot->len < kSlotDataSize ? slot->len : static_cast<uint16_t>(kSlotDataSize);
+            uint16_t offset = slot->message_offset < len ? slot->message_offset : len;
+            uint8_t lvl = slot->level;
+            record.line.assign(slot->data, len);
+
+            // hand the slot back to producers for the next lap
+            slot->seq.store(pos + capacity_, std::memory_order_release);
+            header_->tail.store(pos + 1, std::memory_order_relaxed);
+
+            if (ticket != pos || lvl > static_cast<uint8_t>(LogLevel::Info) ||
+                checksum != SlotChecksum(ticket, len, offset, lvl, record.line.data())) {
+                header_->skipped.fetch_add(1, std::memory_order_relaxed);
+                std::cerr << "SharedMemoryRing: discarded slot overwritten by a stalled producer (ticket "
+                          << pos << ")\n";
+                continue;
+            }
+            record.message_offset = offset;
+            record.level = static_cast<LogLevel>(lvl);
+            return true;
+        }
+
+        if (seq > pos + 1) {
+            // already consumed by a previous drain that stopped before moving tail
+            header_->tail.store(pos + 1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // empty, or claimed by a producer that has not published yet
+        if (header_->head.load(std::memory_order_relaxed) == pos) return false;
+
+        auto now = std::chrono::steady_clock::now();
+        if (stuck_pos_ != pos) {
+            stuck_pos_ = pos;
+            stuck_since_ = now;
+            return false;
+        }
+        if (now - stuck_since_ < stuck_timeout_) return false;
+
+        // producer most likely died between claiming and publishing - skip its slot.
+        // If the CAS fails the producer published meanwhile and the next pass pops it.
+        if (slot->seq.compare_exchange_strong(seq, pos + capacity_, std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+            header_->skipped.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "SharedMemoryRing: skipped slot abandoned by a producer (ticket " << pos << ")\n";
+            header_->tail.store(pos + 1, std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t SharedMemoryRing::DroppedCount() const {
+    return header_->dropped.load(std::memory_order_relaxed);
+}
+
+uint64_t SharedMemoryRing::SkippedCount() const {
+    return header_->skipped.load(std::memory_order_relaxed);
+}
+
+} // namespace LoggerLib
@@ -1,4 +1,7 @@
 #include "Logger/Logger.h"
+#include "Logger/SharedMemoryRing.h"
+#include "Stats/Stats.h"
+#include "Stats/StatsSnapshot.h"
 
 #include <iostream>
 #include <fstream>
@@ -6,6 +9,18 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #define ASSERT_TRUE(expr) \
     do { if (!(expr)) { \
@@ -66,11 +81,423 @@ bool test_socket_destination_create() {
     return true;
 }
 
+bool test_per_destination_routing() {
+    auto logger = std::make_shared<LoggerLib::Logger>(LoggerLib::LogLevel::Info);
+
+    std::string verbose_file = "test_route_verbose.txt";
+    std::string errors_file = "test_route_errors.txt";
+    std::string tagged_file = "test_route_tagged.txt";
+    logger->AddFileDestination(verbose_file);
+    logger->AddFileDestination(errors_file, LoggerLib::LogLevel::Error);
+    logger->AddFileDestination(tagged_file, LoggerLib::LogLevel::Info, LoggerLib::MakePrefixFilter("net:"));
+
+    logger->Log("Error msg", LoggerLib::LogLevel::Error);
+    logger->Log("Info msg", LoggerLib::LogLevel::Info);
+    logger->Log("net: Tagged msg", LoggerLib::LogLevel::Warning);
+
+    auto read_all = [](const std::string& filename) {
+        std::ifstream ifs(filename);
+        std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        ifs.close();
+        std::remove(filename.c_str());
+        return content;
+    };
+    std::string verbose = read_all(verbose_file);
+    std::string errors = read_all(errors_file);
+    std::string tagged = read_all(tagged_file);
+
+    ASSERT_CONTAINS(verbose, "Error msg");
+    ASSERT_CONTAINS(verbose, "Info msg");
+    ASSERT_CONTAINS(verbose, "Tagged msg");
+
+    ASSERT_CONTAINS(errors, "Error msg");
+    ASSERT_FALSE(errors.find("Info msg") != std::string::npos);
+    ASSERT_FALSE(errors.find("Tagged msg") != std::string::npos);
+
+    ASSERT_CONTAINS(tagged, "[Warning] net: Tagged msg");
+    ASSERT_FALSE(tagged.find("Error msg") != std::string::npos);
+    return true;
+}
+
+bool test_shared_memory_ring() {
+#ifdef __linux__
+    // segments outlive the drain - start from a clean name
+    shm_unlink("/logger_test_ring");
+    // segment left by a drain that crashed before initializing it is initialized
+    int stale_fd = shm_open("/logger_test_ring", O_CREAT | O_RDWR, 0666);
+    ASSERT_TRUE(stale_fd >= 0);
+    close(stale_fd);
+#endif
+    auto ring = LoggerLib::SharedMemoryRing::Create("/logger_test_ring", 4);
+    ASSERT_TRUE(ring != nullptr);
+    // ... but a running drain's segment is not taken over
+    ASSERT_TRUE(LoggerLib::SharedMemoryRing::Create("/logger_test_ring", 4) == nullptr);
+
+    // producer side goes through the Logger, as a worker process would
+    auto logger = std::make_shared<LoggerLib::Logger>(LoggerLib::LogLevel::Info);
+    ASSERT_TRUE(logger->AddSharedMemoryDestination("/logger_test_ring"));
+    ASSERT_FALSE(logger->AddSharedMemoryDestination("/logger_test_ring_missing"));
+    logger->Log("First msg", LoggerLib::LogLevel::Error);
+    logger->Log("Second msg mentions [Error]", LoggerLib::LogLevel::Info);
+
+    // level and raw message travel with the line, not parsed back from it
+    LoggerLib::SharedMemoryRecord record;
+    ASSERT_TRUE(ring->TryPop(record));
+    ASSERT_CONTAINS(record.line, "[Error] First msg");
+    ASSERT_EQ(record.Message(), "First msg");
+    ASSERT_TRUE(record.level == LoggerLib::LogLevel::Error);
+    ASSERT_TRUE(ring->TryPop(record));
+    ASSERT_CONTAINS(record.line, "[Info] Second msg");
+    ASSERT_EQ(record.Message(), "Second msg mentions [Error]");
+    ASSERT_TRUE(record.level == LoggerLib::LogLevel::Info);
+    ASSERT_FALSE(ring->TryPop(record));
+
+    // full ring drops instead of blocking
+    auto producer = LoggerLib::SharedMemoryRing::Attach("logger_test_ring");
+    ASSERT_TRUE(producer != nullptr);
+    for (int i = 0; i < 4; ++i) ASSERT_TRUE(producer->TryPush("line " + std::to_string(i)));
+    ASSERT_FALSE(producer->TryPush("overflow"));
+    ASSERT_EQ(ring->DroppedCount(), 1u);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring->TryPop(record));
+        ASSERT_EQ(record.line, "line " + std::to_string(i));
+    }
+
+    // drain restart: pending lines survive and running workers stay connected
+    ASSERT_TRUE(producer->TryPush("pending"));
+    ring.reset();
+    ring = LoggerLib::SharedMemoryRing::Create("/logger_test_ring", 4);
+    ASSERT_TRUE(ring != nullptr);
+    ASSERT_TRUE(ring->TryPop(record));
+    ASSERT_EQ(record.line, "pending");
+    ASSERT_TRUE(producer->TryPush("after restart"));
+    ASSERT_TRUE(ring->TryPop(record));
+    ASSERT_EQ(record.line, "after restart");
+    ASSERT_FALSE(ring->TryPop(record));
+
+    // no drain running (segment left behind): workers must not attach
+    ring.reset();
+    ASSERT_TRUE(LoggerLib::SharedMemoryRing::Attach("/logger_test_ring") == nullptr);
+    auto orphan_logger = std::make_shared<LoggerLib::Logger>(LoggerLib::LogLevel::Info);
+    ASSERT_FALSE(orphan_logger->AddSharedMemoryDestination("/logger_test_ring"));
+
+    // a segment with another layout is not silently reinitialized
+    ASSERT_TRUE(LoggerLib::SharedMemoryRing::Create("/logger_test_ring", 8) == nullptr);
+#ifdef __linux__
+    shm_unlink("/logger_test_ring");
+#endif
+    return true;
+}
+
+namespace LoggerLib {
+// producer steps of SharedMemoryRing, to simulate producers that crash or stall mid-push
+class SharedMemoryRingTest {
+public:
+    static bool Claim(SharedMemoryRing& ring, uint64_t& pos) { return ring.ClaimTicket(pos); }
+    static bool Publish(SharedMemoryRing& ring, uint64_t pos, const std::string& line) {
+        return ring.Publish(pos, line, 0, LogLevel::Info);
+    }
+};
+}
+
+bool test_shared_memory_ring_stuck_slots() {
+    using LoggerLib::SharedMemoryRingTest;
+#ifdef __linux__
+    shm_unlink("/logger_test_stuck");
+#endif
+    auto ring = LoggerLib::SharedMemoryRing::Create("/logger_test_stuck", 4);
+    ASSERT_TRUE(ring != nullptr);
+    ring->SetStuckSlotTimeout(std::chrono::milliseconds(20));
+    auto producer = LoggerLib::SharedMemoryRing::Attach("/logger_test_stuck");
+    ASSERT_TRUE(producer != nullptr);
+    LoggerLib::SharedMemoryRecord record;
+
+    // crashed producer: claims ticket 0 and never publishes it
+    uint64_t dead = 0;
+    ASSERT_TRUE(SharedMemoryRingTest::Claim(*producer, dead));
+    ASSERT_TRUE(producer->TryPush("after dead"));
+    ASSERT_FALSE(ring->TryPop(record)); // waits for ticket 0
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_TRUE(ring->TryPop(record));
+    ASSERT_EQ(record.line, "after dead");
+    ASSERT_EQ(ring->SkippedCount(), 1u);
+
+    // stalled producer: its slot is reclaimed and reused by the next lap before it writes
+    uint64_t stalled = 0;
+    ASSERT_TRUE(SharedMemoryRingTest::Claim(*producer, stalled));
+    ASSERT_FALSE(ring->TryPop(record));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_FALSE(ring->TryPop(record)); // skips it, then the ring is empty
+    ASSERT_EQ(ring->SkippedCount(), 2u);
+
+    const char* lines[] = {"a", "b", "c", "d"}; // "d" lands in the stalled producer's slot
+    for (const char* l : lines) ASSERT_TRUE(producer->TryPush(l));
+    uint64_t dropped = ring->DroppedCount();
+    ASSERT_FALSE(SharedMemoryRingTest::Publish(*producer, stalled, "stale writer"));
+    ASSERT_EQ(ring->DroppedCount(), dropped + 1);
+
+    for (const char* l : {"a", "b", "c"}) {
+        ASSERT_TRUE(ring->TryPop(record));
+        ASSERT_EQ(record.line, l);
+    }
+    // the overwritten slot is discarded, neither "d" nor the stale line is emitted garbled
+    ASSERT_FALSE(ring->TryPop(record));
+    ASSERT_EQ(ring->SkippedCount(), 3u);
+
+    ring.reset();
+#ifdef __linux__
+    shm_unlink("/logger_test_stuck");
+#endif
+    return true;
+}
+
+bool test_normalize_template() {
+    ASSERT_EQ(normalize_template("2026-01-01 12:34:56 [Info] done"), "#-#-# #:#:# [Info] done");
+    // 0x-идентификаторы и hex-слова с цифрами целиком
+    ASSERT_EQ(normalize_template("id 0xDEADbeef ok"), "id # ok");
+    ASSERT_EQ(normalize_template("trace a1b2c3 ok"), "trace # ok");
+    // hex-слово без цифр - обычное слово
+    ASSERT_EQ(normalize_template("deadbeef cafe"), "deadbeef cafe");
+    // смешанные слова: цифры схлопываются в один '#'
+    ASSERT_EQ(normalize_template("IPv4 user123x"), "IPv# user#x");
+    // длина шаблона ограничена
+    ASSERT_EQ(normalize_template(std::string(300, 'x')).size(), MAX_TEMPLATE_LEN);
+    ASSERT_EQ(normalize_template(std::string(200, 'y') + " 42").size(), MAX_TEMPLATE_LEN);
+    return true;
+}
+
+bool test_space_saving_bounds() {
+    SpaceSaving ss;
+    std::vector<std::string> names;
+    std::vector<size_t> truth;
+    auto add = [&](const std::string& name) {
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it == names.end()) {
+            names.push_back(name);
+            truth.push_back(0);
+            it = names.end() - 1;
+        }
+        truth[it - names.begin()]++;
+        ss.add(hash_template(name), name);
+    };
+    // два частых шаблона на фоне множества редких - вытеснений много
+    for (int i = 0; i < 3000; i++) {
+        if (i % 3 == 0) add("heavy A");
+        if (i % 5 == 0) add("heavy B");
+        add("rare " + std::to_string(i % 700));
+    }
+
+    ASSERT_EQ(ss.entries.size(), SpaceSaving::CAPACITY);
+    for (const auto& e : ss.entries) {
+        size_t real = truth[std::find(names.begin(), names.end(), e.templ) - names.begin()];
+        // count - error <= истинное значение <= count
+        ASSERT_TRUE(e.count - e.error <= real);
+        ASSERT_TRUE(real <= e.count);
+    }
+    auto top = ss.top(2);
+    ASSERT_EQ(top[0].templ, "heavy A");
+    ASSERT_EQ(top[1].templ, "heavy B");
+    ASSERT_TRUE(top[0].count - top[0].error >= 1000u - 1);
+    return true;
+}
+
+bool test_hyperloglog_accuracy() {
+    // стандартная ошибка 1.04 / sqrt(4096) ~ 1.6%; допускаем 3 стандартные ошибки
+    for (size_t n : {1000u, 100000u}) {
+        HyperLogLog hll;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t h = hash_template("template " + std::to_string(i));
+            hll.add(h);
+            hll.add(h); // повторы не влияют на оценку
+        }
+        double rel_error = std::abs(hll.estimate() - static_cast<double>(n)) / static_cast<double>(n);
+        ASSERT_TRUE(rel_error < 3 * 0.0163);
+    }
+    ASSERT_EQ(HyperLogLog().estimate(), 0.0);
+    return true;
+}
+
+// сообщение в формате Logger, учтённое в момент now
+static void add_line(Stats& stats, const std::string& line, int64_t now) {
+    std::string templ = normalize_template(line);
+    add_message(stats, line, templ, hash_template(templ), now);
+}
+
+bool test_stats_last_hour_window() {
+    Stats stats;
+    int64_t now = 1000000;
+    add_line(stats, "2026-01-01 00:00:00 [Info] old", now - 4000);
+    add_line(stats, "2026-01-01 00:00:00 [Info] recent", now - 10);
+    add_line(stats, "2026-01-01 00:00:00 [Error] now", now);
+    add_line(stats, "2026-01-01 00:00:00 [Error] now again", now);
+
+    ASSERT_EQ(stats.total_messages, 4u);
+    ASSERT_EQ(last_hour_count(stats, now), 3u);
+    // через час уходят все, кроме последних
+    ASSERT_EQ(last_hour_count(stats, now + 3595), 2u);
+    ASSERT_EQ(last_hour_count(stats, now + 3600), 0u);
+
+    // та же ячейка через час начинается заново
+    add_line(stats, "2026-01-01 01:00:00 [Info] next hour", now + 3600);
+    ASSERT_EQ(last_hour_count(stats, now + 3600), 1u);
+    return true;
+}
+
+bool test_stats_snapshot_round_trip() {
+    std::string filename = "test_stats_snapshot.bin";
+    std::remove(filename.c_str());
+    int64_t now = epoch_seconds();
+
+    Stats stats;
+    std::mutex stats_mutex;
+    add_line(stats, "2026-01-01 00:00:00 [Error] request 1 failed", now);
+    add_line(stats, "2026-01-01 00:00:01 [Error] request 2 failed", now);
+    add_line(stats, "2026-01-01 00:00:02 [Warning] disk 0xdeadbeef slow", now);
+    {
+        SnapshotStore store(stats, stats_mutex);
+        ASSERT_TRUE(store.open(filename));
+        ASSERT_FALSE(store.load()); // новый файл пуст
+        store.save();
+    }
+
+    Stats restored;
+    std::mutex restored_mutex;
+    SnapshotStore store(restored, restored_mutex);
+    ASSERT_TRUE(store.open(filename));
+    ASSERT_TRUE(store.load());
+    std::remove(filename.c_str());
+
+    ASSERT_EQ(restored.total_messages, 3u);
+    ASSERT_EQ(restored.errors, 2u);
+    ASSERT_EQ(restored.warnings, 1u);
+    ASSERT_EQ(restored.min_len, stats.min_len);
+    ASSERT_EQ(restored.max_len, stats.max_len);
+    ASSERT_EQ(restored.avg_len, stats.avg_len);
+    ASSERT_EQ(last_hour_count(restored, now), 3u);
+    ASSERT_EQ(restored.distinct_templates.estimate(), stats.distinct_templates.estimate());
+
+    auto top = restored.top_templates.top(1);
+    ASSERT_EQ(top.size(), 1u);
+    ASSERT_EQ(top[0].count, 2u);
+    ASSERT_EQ(top[0].templ, stats.top_templates.top(1)[0].templ);
+    return true;
+}
+
+bool test_stats_snapshot_torn_slot() {
+    std::string filename = "test_stats_torn.bin";
+    std::remove(filename.c_str());
+    int64_t now = epoch_seconds();
+
+    Stats stats;
+    std::mutex stats_mutex;
+    {
+        SnapshotStore store(stats, stats_mutex);
+        ASSERT_TRUE(store.open(filename));
+        add_line(stats, "2026-01-01 00:00:00 [Info] first", now);
+        store.save(); // поколение 1 - слот 1
+        add_line(stats, "2026-01-01 00:00:00 [Info] second", now);
+        store.save(); // поколение 2 - слот 0
+    }
+
+    // портим данные последнего снимка, как при падении во время записи
+    {
+        std::fstream f(filename, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(offsetof(SnapshotFile, slots) + offsetof(SnapshotSlot, data));
+        f.put('\x7f');
+    }
+
+    Stats restored;
+    std::mutex restored_mutex;
+    SnapshotStore store(restored, restored_mutex);
+    ASSERT_TRUE(store.open(filename));
+    ASSERT_TRUE(store.load());
+    std::remove(filename.c_str());
+
+    ASSERT_EQ(restored.total_messages, 1u);
+    return true;
+}
+
+bool test_stats_snapshot_zeroed_file_is_fresh() {
+    // падение после ftruncate, но до записи заголовка
+    std::string filename = "test_stats_zeroed.bin";
+    {
+        std::ofstream ofs(filename, std::ios::binary);
+        std::string zeros(sizeof(SnapshotFile), '\0');
+        ofs.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+
+    Stats stats;
+    std::mutex stats_mutex;
+    {
+        SnapshotStore store(stats, stats_mutex);
+        ASSERT_TRUE(store.open(filename));
+        ASSERT_FALSE(store.load());
+        add_line(stats, "2026-01-01 00:00:00 [Info] first", epoch_seconds());
+        store.save();
+    }
+
+    Stats restored;
+    std::mutex restored_mutex;
+    SnapshotStore store(restored, restored_mutex);
+    ASSERT_TRUE(store.open(filename));
+    ASSERT_TRUE(store.load());
+    std::remove(filename.c_str());
+    ASSERT_EQ(restored.total_messages, 1u);
+    return true;
+}
+
+bool test_stats_snapshot_rejects_foreign_file() {
+    std::string filename = "test_not_snapshot.txt";
+    {
+        std::ofstream ofs(filename);
+        ofs << "2026-01-01 00:00:00 [Info] a log line\n";
+    }
+
+    Stats stats;
+    std::mutex stats_mutex;
+    SnapshotStore store(stats, stats_mutex);
+    ASSERT_FALSE(store.open(filename));
+
+    std::ifstream ifs(filename);
+    std::string content;
+    std::getline(ifs, content);
+    ifs.close();
+    std::remove(filename.c_str());
+    ASSERT_EQ(content, "2026-01-01 00:00:00 [Info] a log line");
+
+    // файл нужного размера, но не из нулей и без заголовка, тоже чужой
+    {
+        std::ofstream ofs(filename, std::ios::binary);
+        std::string data(sizeof(SnapshotFile), '\0');
+        data[sizeof(SnapshotFile) / 2] = 'x';
+        ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    ASSERT_FALSE(store.open(filename));
+    std::ifstream check(filename, std::ios::binary);
+    std::string after((std::istreambuf_iterator<char>(check)), std::istreambuf_iterator<char>());
+    check.close();
+    std::remove(filename.c_str());
+    ASSERT_EQ(after.size(), sizeof(SnapshotFile));
+    ASSERT_EQ(after[sizeof(SnapshotFile) / 2], 'x');
+    return true;
+}
+
 int main() {
     std::vector<std::pair<std::string, bool(*)()>> tests = {
         {"LogLevel filtering works", test_level_filtering},
         {"FileDestination writes to file", test_file_destination_write},
-        {"SocketDestination creates without server", test_socket_destination_create}
+        {"SocketDestination creates without server", test_socket_destination_create},
+        {"Per-destination level and filter routing", test_per_destination_routing},
+        {"SharedMemoryRing transports lines", test_shared_memory_ring},
+        {"SharedMemoryRing skips stuck and overwritten slots", test_shared_memory_ring_stuck_slots},
+        {"Template normalization", test_normalize_template},
+        {"SpaceSaving keeps count bounds", test_space_saving_bounds},
+        {"HyperLogLog estimate accuracy", test_hyperloglog_accuracy},
+        {"Stats last hour window", test_stats_last_hour_window},
+        {"Stats snapshot round trip", test_stats_snapshot_round_trip},
+        {"Stats snapshot falls back from torn slot", test_stats_snapshot_torn_slot},
+        {"Stats snapshot treats zeroed file as fresh", test_stats_snapshot_zeroed_file_is_fresh},
+        {"Stats snapshot rejects foreign file", test_stats_snapshot_rejects_foreign_file}
     };
 
     int passed = 0;